@@ -0,0 +1,134 @@
+# AFL dictionary generator, run by run_afl.sh:
+#   python3 afl_dict.py <source_path> <dict_file>
+#
+# Collects the tokens the program compares its input against: string literals,
+# the operands of strcmp/strncmp/memcmp/compare and similar calls, the characters
+# of strtok/strchr delimiters and printable character literals. They are written
+# in AFL's dictionary format (name="value") for afl-fuzz -x, so keyword-driven
+# inputs are reached without AFL having to guess every byte of the keyword.
+import re
+import sys
+
+# AFL++ rejects dictionary tokens longer than this
+MAX_TOKEN = 128
+# Longer literals that are never compared are messages, not input syntax
+MAX_LITERAL = 16
+
+LITERAL = re.compile(r'"((?:[^"\\\n]|\\.)*)"|\'((?:[^\'\\\n]|\\.){1,4})\'')
+COMMENT = re.compile(r'//[^\n]*|/\*.*?\*/|("(?:[^"\\\n]|\\.)*"|\'(?:[^\'\\\n]|\\.)*\')', re.DOTALL)
+# Calls whose literal operand is matched against the input
+COMPARE_CALL = re.compile(r'\b(?:strn?cmp|strn?casecmp|memcmp|strstr|compare|find|rfind|starts_with|ends_with)\s*\($')
+# Calls whose literal operand is a set of single delimiter characters
+DELIMITER_CALL = re.compile(r'\b(?:strtok|strtok_r|strsep|strpbrk|strspn|strcspn|strchr|strrchr|memchr|getline|find_first_of)\s*\($')
+# std::string and similar operands compared with == or !=
+EQUALITY = re.compile(r'[!=]=\s*$')
+EQUALITY_AFTER = re.compile(r'\s*[!=]=')
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "0": "\0", "\\": "\\", '"': '"', "'": "'", "a": "\a", "b": "\b", "f": "\f", "v": "\v"}
+
+
+def strip_comments(code):
+    """Drop comments but keep string and character literals intact."""
+    return COMMENT.sub(lambda m: m.group(1) or " ", code)
+
+
+def unescape(text):
+    """Decode the C escape sequences of a literal into bytes."""
+    out = bytearray()
+    i = 0
+    while i < len(text):
+        if text[i] != "\\" or i + 1 == len(text):
+            out += text[i].encode()
+            i += 1
+            continue
+        escape = text[i + 1]
+        if escape == "x":
+            digits = re.match(r'[0-9a-fA-F]{1,2}', text[i + 2:])
+            if digits:
+                out.append(int(digits.group(0), 16))
+                i += 2 + len(digits.group(0))
+                continue
+        elif escape in "01234567":
+            digits = re.match(r'[0-7]{1,3}', text[i + 1:]).group(0)
+            out.append(int(digits, 8) & 0xff)
+            i += 1 + len(digits)
+            continue
+        out += ESCAPES.get(escape, escape).encode()
+        i += 2
+    return bytes(out)
+
+
+def is_format(token):
+    """printf-style format strings are output, never compared against the input."""
+    return re.search(rb'%[-+ #0-9.]*[hlzjt]*[diouxXeEfgGcsp]', token) is not None
+
+
+def extract_tokens(code):
+    """Ordered, de-duplicated tokens: compared operands first, then delimiters and other literals."""
+    code = strip_comments(code)
+    compared, delimiters, literals = [], [], []
+    for match in LITERAL.finditer(code):
+        prefix = code[max(0, match.start() - 200):match.start()]
+        # The literal is an argument of the innermost call still open before it
+        depth, call_end = 0, None
+        for j in range(len(prefix) - 1, -1, -1):
+            if prefix[j] == ")":
+                depth += 1
+            elif prefix[j] == "(":
+                if depth == 0:
+                    call_end = j + 1
+                    break
+                depth -= 1
+        call = prefix[:call_end] if call_end else ""
+
+        if match.group(1) is not None:
+            token = unescape(match.group(1))
+            if call and DELIMITER_CALL.search(call[-30:]):
+                delimiters.extend(bytes([c]) for c in token)
+            elif call and COMPARE_CALL.search(call[-30:]) or EQUALITY.search(prefix) or EQUALITY_AFTER.match(code, match.end()):
+                compared.append(token)
+            elif len(token) <= MAX_LITERAL and not is_format(token) and not (len(token) > 1 and token.endswith(b"\n")):
+                literals.append(token)
+        else:
+            token = unescape(match.group(2))
+            # Printable punctuation and whitespace act as separators in these formats
+            if len(token) == 1 and not token.isalnum() and (token.isspace() or 0x21 <= token[0] < 0x7f):
+                delimiters.append(token)
+
+    tokens, seen = [], set()
+    for token in compared + delimiters + literals:
+        if token and len(token) <= MAX_TOKEN and token not in seen:
+            seen.add(token)
+            tokens.append(token)
+    return tokens
+
+
+def dict_value(token):
+    """Quote a token the way AFL's dictionary parser expects."""
+    out = []
+    for byte in token:
+        if byte in (0x22, 0x5c):
+            out.append("\\" + chr(byte))
+        elif 0x20 <= byte < 0x7f:
+            out.append(chr(byte))
+        else:
+            out.append(f"\\x{byte:02x}")
+    return '"' + "".join(out) + '"'
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(f"Usage: {sys.argv[0]} <source_path> <dict_file>")
+        sys.exit(1)
+
+    source_path, dict_file = sys.argv[1:]
+    with open(source_path, errors="ignore") as source:
+        tokens = extract_tokens(source.read())
+
+    with open(dict_file, "w") as output:
+        for index, token in enumerate(tokens):
+            output.write(f"token_{index}={dict_value(token)}\n")
+    print(f"{len(tokens)} tokens written to {dict_file}")
+
+
+if __name__ == "__main__":
+    main()
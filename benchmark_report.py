@@ -0,0 +1,103 @@
+# Benchmark report, run by run_benchmark.sh:
+#   python3 benchmark_report.py <bench_dir>
+#
+# Collects the metrics.json written by every run in <bench_dir>/<target>/run<n>/ and
+# writes one row per run to results.csv, and the runs plus a per-target summary
+# (success rate and mean of every metric) to results.json.
+import csv
+import glob
+import json
+import os
+import sys
+from statistics import mean
+
+COLUMNS = [
+    "target", "run", "outcome", "iterations", "wall_time", "time_to_first_crash", "execs_per_sec",
+    "crash_buckets", "triage_time", "llm_calls", "llm_latency", "llm_input_tokens", "llm_output_tokens",
+]
+
+
+def run_row(target, run, metrics):
+    """Flatten one run's metrics into a results row."""
+    if not metrics:
+        return dict({column: None for column in COLUMNS}, target=target, run=run, outcome="error")
+    campaigns = metrics.get("campaigns", [])
+    triage = metrics.get("triage", [])
+    llm_calls = metrics.get("llm_calls", [])
+    return {
+        "target": target,
+        "run": run,
+        "outcome": metrics.get("outcome", "error"),
+        "iterations": metrics.get("iterations"),
+        "wall_time": metrics.get("wall_time"),
+        # The initial campaign on the buggy code is the one that measures bug finding
+        "time_to_first_crash": campaigns[0]["time_to_first_crash"] if campaigns else None,
+        "execs_per_sec": mean(c["execs_per_sec"] for c in campaigns) if campaigns else None,
+        "crash_buckets": triage[0]["buckets"] if triage else None,
+        "triage_time": sum(t["triage_time"] for t in triage),
+        "llm_calls": len(llm_calls),
+        "llm_latency": sum(c["latency"] for c in llm_calls),
+        "llm_input_tokens": sum(c["input_tokens"] for c in llm_calls),
+        "llm_output_tokens": sum(c["output_tokens"] for c in llm_calls),
+    }
+
+
+def mean_of(rows, column):
+    values = [row[column] for row in rows if row[column] is not None]
+    return mean(values) if values else None
+
+
+def summarize(rows):
+    fixed = [row for row in rows if row["outcome"] == "fixed"]
+    summary = {
+        "runs": len(rows),
+        "success_rate": len(fixed) / len(rows) if rows else 0.0,
+        "iterations_to_fix": mean_of(fixed, "iterations"),
+    }
+    for column in COLUMNS[4:]:
+        summary[column] = mean_of(rows, column)
+    return summary
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(f"Usage: {sys.argv[0]} <bench_dir>")
+        sys.exit(1)
+
+    bench_dir = sys.argv[1]
+    rows = []
+    for workspace in sorted(glob.glob(os.path.join(bench_dir, "*", "run*"))):
+        target = os.path.basename(os.path.dirname(workspace))
+        run = int(os.path.basename(workspace)[len("run"):])
+        metrics_path = os.path.join(workspace, "metrics.json")
+        # A run whose notebook died before the loop finished counts as an error
+        metrics = {}
+        if os.path.isfile(metrics_path):
+            with open(metrics_path) as file:
+                metrics = json.load(file)
+        rows.append(run_row(target, run, metrics))
+
+    targets = sorted({row["target"] for row in rows})
+    results = {
+        "settings": {key: value for key, value in sorted(os.environ.items())
+                     if key.startswith("APR_") and key not in ("APR_SUDO_PASSWORD", "APR_TARGET", "APR_METRICS")},
+        "summary": {target: summarize([row for row in rows if row["target"] == target]) for target in targets},
+        "overall": summarize(rows),
+        "runs": rows,
+    }
+
+    with open(os.path.join(bench_dir, "results.json"), "w") as file:
+        json.dump(results, file, indent=1)
+    with open(os.path.join(bench_dir, "results.csv"), "w", newline="") as file:
+        writer = csv.DictWriter(file, fieldnames=COLUMNS)
+        writer.writeheader()
+        writer.writerows(rows)
+
+    for target in targets:
+        summary = results["summary"][target]
+        print(f"{target}: {summary['success_rate']:.0%} fixed over {summary['runs']} runs")
+    print(f"Results written to {bench_dir}/results.json and {bench_dir}/results.csv")
+
+
+if __name__ == "__main__":
+    main()
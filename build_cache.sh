@@ -0,0 +1,57 @@
+#!/bin/bash
+
+# Content-addressed cache of compiled binaries, sourced by run_afl.sh and run_gdb.sh.
+# A build is keyed by the compiler, its version, the flags and the contents of the
+# source and of any file it includes, so every version of the code is compiled once
+# per compiler/flag combination and reused across iterations and runs.
+BUILD_CACHE_DIR="${BUILD_CACHE_DIR:-.build_cache}"
+
+source "$(dirname "${BASH_SOURCE[0]}")/trace.sh"
+
+# compiler_for <source> <c_compiler> <cxx_compiler>
+# Pick the C or C++ compiler from the file extension
+compiler_for() {
+    if [[ "$1" == *.c ]]; then
+        echo "$2"
+    else
+        echo "$3"
+    fi
+}
+
+# cached_build <output> <compiler> "<flags>" <source> [dependency...]
+# Compile source into output unless an identical build is already cached.
+# BUILD_ENV="VAR=value ..." sets compiler environment variables (like AFL_LLVM_CMPLOG=1)
+# and is part of the key. Compiler errors are appended to compilation_log.txt.
+cached_build() {
+    local output="$1"
+    local compiler="$2"
+    local flags="$3"
+    local source="$4"
+    shift 4
+    local start
+    start=$(trace_now)
+
+    local key
+    key=$( {
+        echo "$compiler $flags${BUILD_ENV:+ $BUILD_ENV}"
+        "$compiler" --version 2>/dev/null | head -n 1
+        cat "$source" "$@"
+    } | sha256sum | cut -d ' ' -f 1)
+    local cached="$BUILD_CACHE_DIR/$key"
+    local hit=true
+
+    if [ ! -x "$cached" ]; then
+        hit=false
+        mkdir -p "$BUILD_CACHE_DIR"
+        # Build next to the cache entry and rename, so a concurrent run never sees half a binary
+        # shellcheck disable=SC2086
+        if ! env ${BUILD_ENV:-} "$compiler" $flags "$source" -o "$cached.$$" 2>> compilation_log.txt; then
+            trace_span "compile $(basename "$output")" "$start" "{\"compiler\": \"$compiler\", \"cached\": false, \"failed\": true}"
+            return 1
+        fi
+        mv -f "$cached.$$" "$cached"
+    fi
+
+    cp -f "$cached" "$output"
+    trace_span "compile $(basename "$output")" "$start" "{\"compiler\": \"$compiler\", \"cached\": $hit}"
+}
@@ -0,0 +1,384 @@
+/*
+ * Structure-aware AFL++ custom mutator for count- and length-prefixed binary
+ * formats, built and loaded by run_afl.sh when a format description is given:
+ *   gcc -shared -fPIC -O2 format_mutator.c -o format_mutator.so
+ *   AFL_CUSTOM_MUTATOR_LIBRARY=format_mutator.so FORMAT_MUTATOR_SCHEMA=<target>.fmt afl-fuzz ...
+ *
+ * The description is a sequence of fields, all little-endian:
+ *   u32           a 4-byte scalar
+ *   blob          a u32 length followed by that many bytes
+ *   count { ... } a u32 count followed by that many repetitions of the fields in braces
+ * '#' starts a comment. bug8.c, for example, is "count { blob }".
+ *
+ * Inputs are parsed into fields, mutated at the field level (boundary values,
+ * records duplicated, removed or spliced in from another input with the count
+ * kept consistent, blobs grown or shrunk with their length) and written back,
+ * so most mutated inputs still get past the parser. AFL's own havoc stage
+ * keeps running alongside and covers the byte-level mutations.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Bounds keep a huge declared count or length from exhausting memory while parsing */
+#define MAX_ELEMENTS 1024
+#define MAX_FIELDS 4096
+
+enum kind { SEQUENCE, U32, BLOB, COUNT };
+
+struct schema {
+    enum kind kind;
+    struct schema **items; /* fields of a sequence or of one count repetition */
+    size_t n_items;
+};
+
+struct value {
+    const struct schema *schema;
+    uint32_t declared;        /* scalar value, blob length or count as written to the input */
+    uint8_t *data;            /* blob bytes actually present */
+    size_t len;
+    struct value **elements;  /* count repetitions, each an array of schema->n_items values */
+    size_t n_elements;
+};
+
+struct mutator {
+    struct schema *schema;
+    uint64_t rng;
+    uint8_t *out;
+    size_t out_len, out_cap;
+    struct value *fields[MAX_FIELDS];
+    size_t n_fields;
+};
+
+static const uint32_t BOUNDARIES[] = {
+    0, 1, 2, 3, 4, 7, 8, 16, 0x7f, 0x80, 0xff, 0x100, 0x7fff, 0x8000, 0xffff, 0x10000,
+    0x3fffffff, 0x40000000, 0x7fffffff, 0x80000000, 0xfffffffe, 0xffffffff,
+};
+
+static uint64_t next_random(struct mutator *m) {
+    m->rng ^= m->rng << 13;
+    m->rng ^= m->rng >> 7;
+    m->rng ^= m->rng << 17;
+    return m->rng;
+}
+
+static size_t pick(struct mutator *m, size_t n) {
+    return n ? next_random(m) % n : 0;
+}
+
+/* Schema parsing */
+
+static const char *next_token(const char **cursor, size_t *len) {
+    const char *p = *cursor;
+    for (;;) {
+        while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+        if (*p != '#') break;
+        while (*p && *p != '\n') p++;
+    }
+    if (!*p) {
+        *cursor = p;
+        return NULL;
+    }
+    const char *start = p;
+    if (*p == '{' || *p == '}') {
+        p++;
+    } else {
+        while (*p && *p != '{' && *p != '}' && *p != '#' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') p++;
+    }
+    *len = p - start;
+    *cursor = p;
+    return start;
+}
+
+static struct schema *new_schema(enum kind kind) {
+    struct schema *s = calloc(1, sizeof(*s));
+    s->kind = kind;
+    return s;
+}
+
+static void add_item(struct schema *parent, struct schema *item) {
+    parent->items = realloc(parent->items, (parent->n_items + 1) * sizeof(*parent->items));
+    parent->items[parent->n_items++] = item;
+}
+
+static void free_schema(struct schema *s) {
+    if (!s) return;
+    for (size_t i = 0; i < s->n_items; i++) free_schema(s->items[i]);
+    free(s->items);
+    free(s);
+}
+
+/* Parse fields into parent until the closing brace (or the end of the description at the top) */
+static int parse_items(const char **cursor, struct schema *parent, int nested) {
+    const char *token;
+    size_t len;
+    while ((token = next_token(cursor, &len)) != NULL) {
+        if (len == 1 && *token == '}') return nested ? 0 : -1;
+        if (len == 3 && strncmp(token, "u32", 3) == 0) {
+            add_item(parent, new_schema(U32));
+        } else if (len == 4 && strncmp(token, "blob", 4) == 0) {
+            add_item(parent, new_schema(BLOB));
+        } else if (len == 5 && strncmp(token, "count", 5) == 0) {
+            struct schema *count = new_schema(COUNT);
+            add_item(parent, count);
+            token = next_token(cursor, &len);
+            if (!token || len != 1 || *token != '{' || parse_items(cursor, count, 1) != 0 || !count->n_items) return -1;
+        } else {
+            return -1;
+        }
+    }
+    return nested ? -1 : 0;
+}
+
+static struct schema *load_schema(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return NULL;
+    char text[4096];
+    size_t n = fread(text, 1, sizeof(text) - 1, f);
+    fclose(f);
+    text[n] = '\0';
+
+    struct schema *root = new_schema(SEQUENCE);
+    const char *cursor = text;
+    if (parse_items(&cursor, root, 0) != 0 || !root->n_items) {
+        free_schema(root);
+        return NULL;
+    }
+    return root;
+}
+
+/* Input parsing and serialization */
+
+static void free_values(struct value *values, size_t n);
+
+static void free_value_contents(struct value *v) {
+    free(v->data);
+    for (size_t i = 0; i < v->n_elements; i++) free_values(v->elements[i], v->schema->n_items);
+    free(v->elements);
+}
+
+static void free_values(struct value *values, size_t n) {
+    for (size_t i = 0; i < n; i++) free_value_contents(&values[i]);
+    free(values);
+}
+
+static uint32_t read_u32(const uint8_t *buf, size_t len, size_t *pos) {
+    uint8_t bytes[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4 && *pos < len; i++) bytes[i] = buf[(*pos)++];
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static struct value *parse_values(const struct schema *s, const uint8_t *buf, size_t len, size_t *pos);
+
+static void parse_value(struct value *v, const struct schema *s, const uint8_t *buf, size_t len, size_t *pos) {
+    v->schema = s;
+    v->declared = read_u32(buf, len, pos);
+    if (s->kind == BLOB) {
+        /* A length past the end of the input keeps only the bytes that are there */
+        v->len = v->declared < len - *pos ? v->declared : len - *pos;
+        v->data = malloc(v->len ? v->len : 1);
+        memcpy(v->data, buf + *pos, v->len);
+        *pos += v->len;
+    } else if (s->kind == COUNT) {
+        while (v->n_elements < v->declared && v->n_elements < MAX_ELEMENTS && *pos < len) {
+            v->elements = realloc(v->elements, (v->n_elements + 1) * sizeof(*v->elements));
+            v->elements[v->n_elements++] = parse_values(s, buf, len, pos);
+        }
+    }
+}
+
+static struct value *parse_values(const struct schema *s, const uint8_t *buf, size_t len, size_t *pos) {
+    struct value *values = calloc(s->n_items, sizeof(*values));
+    for (size_t i = 0; i < s->n_items; i++) parse_value(&values[i], s->items[i], buf, len, pos);
+    return values;
+}
+
+static int reserve(struct mutator *m, size_t extra) {
+    if (m->out_len + extra <= m->out_cap) return 0;
+    size_t cap = m->out_cap ? m->out_cap : 4096;
+    while (cap < m->out_len + extra) cap *= 2;
+    uint8_t *out = realloc(m->out, cap);
+    if (!out) return -1;
+    m->out = out;
+    m->out_cap = cap;
+    return 0;
+}
+
+static void write_bytes(struct mutator *m, const void *bytes, size_t n) {
+    if (reserve(m, n) == 0) {
+        memcpy(m->out + m->out_len, bytes, n);
+        m->out_len += n;
+    }
+}
+
+static void write_values(struct mutator *m, const struct value *values, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const struct value *v = &values[i];
+        uint8_t bytes[4] = {v->declared, v->declared >> 8, v->declared >> 16, v->declared >> 24};
+        write_bytes(m, bytes, 4);
+        if (v->schema->kind == BLOB) {
+            write_bytes(m, v->data, v->len);
+        } else if (v->schema->kind == COUNT) {
+            for (size_t e = 0; e < v->n_elements; e++) write_values(m, v->elements[e], v->schema->n_items);
+        }
+    }
+}
+
+static struct value *clone_values(const struct value *values, size_t n) {
+    struct value *copy = calloc(n, sizeof(*copy));
+    for (size_t i = 0; i < n; i++) {
+        copy[i] = values[i];
+        copy[i].data = NULL;
+        copy[i].elements = NULL;
+        if (values[i].schema->kind == BLOB) {
+            copy[i].data = malloc(values[i].len ? values[i].len : 1);
+            memcpy(copy[i].data, values[i].data, values[i].len);
+        } else if (values[i].schema->kind == COUNT && values[i].n_elements) {
+            copy[i].elements = malloc(values[i].n_elements * sizeof(*copy[i].elements));
+            for (size_t e = 0; e < values[i].n_elements; e++)
+                copy[i].elements[e] = clone_values(values[i].elements[e], values[i].schema->n_items);
+        }
+    }
+    return copy;
+}
+
+/* Every field of the parsed input, in input order, so one can be picked at random */
+static void collect_fields(struct mutator *m, struct value *values, size_t n) {
+    for (size_t i = 0; i < n && m->n_fields < MAX_FIELDS; i++) {
+        m->fields[m->n_fields++] = &values[i];
+        if (values[i].schema->kind == COUNT) {
+            for (size_t e = 0; e < values[i].n_elements; e++) collect_fields(m, values[i].elements[e], values[i].schema->n_items);
+        }
+    }
+}
+
+/* A count field of the other input with the same schema node, for splicing */
+static struct value *find_count(struct value *values, size_t n, const struct schema *s) {
+    for (size_t i = 0; i < n; i++) {
+        if (values[i].schema == s && values[i].n_elements) return &values[i];
+        if (values[i].schema->kind == COUNT) {
+            for (size_t e = 0; e < values[i].n_elements; e++) {
+                struct value *found = find_count(values[i].elements[e], values[i].schema->n_items, s);
+                if (found) return found;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void insert_element(struct value *v, size_t at, struct value *element) {
+    v->elements = realloc(v->elements, (v->n_elements + 1) * sizeof(*v->elements));
+    memmove(&v->elements[at + 1], &v->elements[at], (v->n_elements - at) * sizeof(*v->elements));
+    v->elements[at] = element;
+    v->n_elements++;
+    v->declared = v->n_elements;
+}
+
+static void mutate_field(struct mutator *m, struct value *v, struct value *other, size_t n_other) {
+    size_t choice = pick(m, 6);
+    switch (choice) {
+    case 0:
+        /* Boundary value, counts and lengths are left inconsistent on purpose */
+        v->declared = BOUNDARIES[pick(m, sizeof(BOUNDARIES) / sizeof(*BOUNDARIES))];
+        return;
+    case 1:
+        v->declared += pick(m, 2) ? 1 : -1;
+        return;
+    default:
+        break;
+    }
+
+    if (v->schema->kind == COUNT) {
+        struct value *donor = other ? find_count(other, n_other, v->schema) : NULL;
+        if (choice == 2 && v->n_elements) {
+            /* Remove a repetition and keep the count consistent */
+            size_t at = pick(m, v->n_elements);
+            free_values(v->elements[at], v->schema->n_items);
+            memmove(&v->elements[at], &v->elements[at + 1], (v->n_elements - at - 1) * sizeof(*v->elements));
+            v->n_elements--;
+            v->declared = v->n_elements;
+        } else if (choice == 3 && donor && v->n_elements < MAX_ELEMENTS) {
+            /* Splice in a repetition of the other input */
+            insert_element(v, pick(m, v->n_elements + 1),
+                           clone_values(donor->elements[pick(m, donor->n_elements)], v->schema->n_items));
+        } else if (v->n_elements && v->n_elements < MAX_ELEMENTS) {
+            /* Duplicate a repetition */
+            insert_element(v, pick(m, v->n_elements + 1),
+                           clone_values(v->elements[pick(m, v->n_elements)], v->schema->n_items));
+        } else {
+            v->declared = pick(m, 17);
+        }
+    } else if (v->schema->kind == BLOB) {
+        if (choice == 2) {
+            /* Shrink the data together with its length */
+            v->len = pick(m, v->len + 1);
+        } else if (choice == 3 || !v->len) {
+            /* Grow the data together with its length */
+            size_t extra = 1 + pick(m, 64);
+            v->data = realloc(v->data, v->len + extra);
+            for (size_t i = 0; i < extra; i++) v->data[v->len + i] = (uint8_t)next_random(m);
+            v->len += extra;
+        } else {
+            v->data[pick(m, v->len)] = (uint8_t)next_random(m);
+            return;
+        }
+        v->declared = v->len;
+    } else {
+        v->declared = pick(m, 17);
+    }
+}
+
+/* AFL++ custom mutator API */
+
+void *afl_custom_init(void *afl, unsigned int seed) {
+    (void)afl;
+    const char *path = getenv("FORMAT_MUTATOR_SCHEMA");
+    struct schema *schema = path ? load_schema(path) : NULL;
+    if (!schema) {
+        fprintf(stderr, "format_mutator: FORMAT_MUTATOR_SCHEMA must name a valid format description\n");
+        return NULL;
+    }
+    struct mutator *m = calloc(1, sizeof(*m));
+    m->schema = schema;
+    m->rng = seed ? seed : 0x9e3779b97f4a7c15ULL;
+    return m;
+}
+
+size_t afl_custom_fuzz(void *data, uint8_t *buf, size_t buf_size, uint8_t **out_buf,
+                       uint8_t *add_buf, size_t add_buf_size, size_t max_size) {
+    struct mutator *m = data;
+    size_t pos = 0;
+    struct value *values = parse_values(m->schema, buf, buf_size, &pos);
+    struct value *other = NULL;
+    if (add_buf && add_buf_size) {
+        size_t other_pos = 0;
+        other = parse_values(m->schema, add_buf, add_buf_size, &other_pos);
+    }
+
+    /* Stack a few field mutations, like havoc stacks byte mutations */
+    size_t rounds = 1 + pick(m, 4);
+    for (size_t r = 0; r < rounds; r++) {
+        m->n_fields = 0;
+        collect_fields(m, values, m->schema->n_items);
+        mutate_field(m, m->fields[pick(m, m->n_fields)], other, m->schema->n_items);
+    }
+
+    m->out_len = 0;
+    write_values(m, values, m->schema->n_items);
+    /* Bytes past the described structure are kept as they were */
+    if (pos < buf_size) write_bytes(m, buf + pos, buf_size - pos);
+
+    free_values(values, m->schema->n_items);
+    if (other) free_values(other, m->schema->n_items);
+
+    *out_buf = m->out;
+    return m->out_len < max_size ? m->out_len : max_size;
+}
+
+void afl_custom_deinit(void *data) {
+    struct mutator *m = data;
+    free_schema(m->schema);
+    free(m->out);
+    free(m);
+}
@@ -3,6 +3,16 @@
 # Check if a file path is provided
 if [ "$#" -ne 4 ]; then
   echo "Usage: $0 <file_path> <fuzz_time> <input_type> <sudo_password>"
+  echo "Optional: FUZZ_JOBS=<n> runs one main (-M) and n-1 secondary (-S) instances (default: nproc)"
+  echo "Optional: HARNESS_PATH=<harness_file> fuzzes a persistent-mode harness built with afl-clang-fast"
+  echo "Optional: CORPUS_DIR=<dir> seeds the campaign with the afl-cmin minimized contents of dir instead of input"
+  echo "Optional: STOP_CRASHES=<k> stops early once the instances saved k unique crashes"
+  echo "Optional: STOP_PLATEAU=<t> stops early once edges_found has not grown for t seconds and no crash was found"
+  echo "Optional: AFL_CPUS=<cpu,cpu,...> pins instance i to the i-th listed CPU with afl-fuzz -b"
+  echo "Optional: DICTIONARY=1 gives every instance a dictionary of the tokens found in the source (afl-fuzz -x)"
+  echo "Optional: FORMAT_PATH=<fmt_file> adds the structure-aware format_mutator for the binary layout described in fmt_file"
+  echo "Optional: LIBFUZZER_HARNESS=<harness_file> runs an in-process libFuzzer instance of the harness next to AFL"
+  echo "Optional: CMPLOG=1 fuzzes an afl-clang-lto build, with a CmpLog companion on the main instance and a laf-intel build on one secondary"
   exit 1
 fi
 
@@ -11,25 +21,259 @@ file_name="${file_path%.*}"
 fuzz_time=$2
 input_type=$3
 sudo_password=$4
+fuzz_jobs="${FUZZ_JOBS:-$(nproc)}"
+harness_path="${HARNESS_PATH:-}"
+corpus_dir="${CORPUS_DIR:-}"
+stop_crashes="${STOP_CRASHES:-0}"
+stop_plateau="${STOP_PLATEAU:-0}"
+IFS=',' read -r -a afl_cpus <<< "${AFL_CPUS:-}"
+dictionary="${DICTIONARY:-0}"
+format_path="${FORMAT_PATH:-}"
+cmplog="${CMPLOG:-0}"
+libfuzzer_harness="${LIBFUZZER_HARNESS:-}"
+seed_dir=input
+fuzz_target="$file_name"
+fuzz_args=("$input_type")
+dict_args=()
+cmplog_args=()
+laf_target=""
+libfuzzer_target=""
+
+source "$(dirname "$0")/build_cache.sh"
+
+# run_path <binary>
+# Path to execute binary by: absolute paths as they are, relative ones from the cwd
+run_path() {
+    if [[ "$1" == /* ]]; then
+        echo "$1"
+    else
+        echo "./$1"
+    fi
+}
 
 # Set up core pattern for crash dumps
 echo "$sudo_password" | sudo -S sh -c 'echo "core" > /proc/sys/kernel/core_pattern'
 
-# Compile the file with afl-gcc and address sanitizer
-afl-gcc -g -w "$file_path" -o "$file_name" 2> compilation_log.txt
-afl-g++ -g -w "$file_path" -o "$file_name" 2>> compilation_log.txt
+# Compile the file with afl-gcc or afl-g++, reusing a cached build of identical source
+: > compilation_log.txt
+cached_build "$file_name" "$(compiler_for "$file_path" afl-gcc afl-g++)" "-g -w" "$file_path"
+
+# The persistent-mode harness needs __AFL_LOOP and the shared-memory testcase
+# buffer, which only afl-clang-fast provides. The harness includes the source,
+# so both are part of its cache key.
+if [ -n "$harness_path" ]; then
+    harness_name="${harness_path%.*}"
+    harness_cc=$(compiler_for "$harness_path" afl-clang-fast afl-clang-fast++)
+    if cached_build "$harness_name" "$harness_cc" "-g -w" "$harness_path" "$file_path"; then
+        # Testcases arrive through shared memory, so AFL gets no @@ file to write
+        fuzz_target="$harness_name"
+        fuzz_args=()
+    fi
+fi
+
+# The libFuzzer harness runs the target in-process, with AddressSanitizer reports for free.
+# It takes the place of the last secondary instance.
+if [ -n "$libfuzzer_harness" ]; then
+    libfuzzer_name="${libfuzzer_harness%.*}"
+    libfuzzer_cc=$(compiler_for "$libfuzzer_harness" clang clang++)
+    if cached_build "$libfuzzer_name" "$libfuzzer_cc" "-g -O1 -w -fsanitize=fuzzer,address" "$libfuzzer_harness" "$file_path"; then
+        libfuzzer_target="$(realpath "$libfuzzer_name")"
+    fi
+fi
+
+# Magic values and keywords compared against the input are solved by input-to-state
+# correspondence instead of brute force: the main instance gets a CmpLog companion
+# binary (afl-fuzz -c) and one secondary fuzzes a laf-intel build whose multi-byte
+# comparisons are split into single bytes. All three come from the same source as
+# the fuzz target, built with afl-clang-lto, or afl-clang-fast where LTO is missing.
+if [ "$cmplog" = "1" ]; then
+    variant_source="$file_path"
+    variant_deps=()
+    if [ "$fuzz_target" != "$file_name" ]; then
+        variant_source="$harness_path"
+        variant_deps=("$file_path")
+    fi
+    llvm_cc=afl-clang-lto
+    if ! command -v afl-clang-lto > /dev/null; then
+        llvm_cc=afl-clang-fast
+    fi
+    llvm_cc=$(compiler_for "$variant_source" "$llvm_cc" "$llvm_cc++")
+    variant_base="$fuzz_target"
+    if cached_build "${variant_base}_lto" "$llvm_cc" "-g -w" "$variant_source" "${variant_deps[@]}"; then
+        fuzz_target="${variant_base}_lto"
+        if BUILD_ENV="AFL_LLVM_CMPLOG=1" cached_build "${variant_base}_cmplog" "$llvm_cc" "-g -w" "$variant_source" "${variant_deps[@]}"; then
+            cmplog_args=(-c "$(run_path "${variant_base}_cmplog")")
+        fi
+        if BUILD_ENV="AFL_LLVM_LAF_ALL=1" cached_build "${variant_base}_laf" "$llvm_cc" "-g -w" "$variant_source" "${variant_deps[@]}"; then
+            laf_target="${variant_base}_laf"
+        fi
+    fi
+fi
+
+# Keywords, compared strings and delimiters of this version of the code, so AFL
+# splices whole tokens like CALC or "CONFIG " instead of guessing them byte by byte
+if [ "$dictionary" = "1" ]; then
+    dict_start=$(trace_now)
+    if python3 "$(dirname "$0")/afl_dict.py" "$file_path" "$file_name.dict" > /dev/null 2>&1 \
+        && [ -s "$file_name.dict" ]; then
+        dict_args=(-x "$file_name.dict")
+    fi
+    trace_span afl-dict "$dict_start" "{\"tokens\": $(cat "$file_name.dict" 2>/dev/null | wc -l)}"
+fi
+
+# Count- and length-prefixed inputs are also mutated field by field, so counts, lengths
+# and records change together instead of byte flips truncating the structure
+if [ -n "$format_path" ] && [ -f "$format_path" ]; then
+    if cached_build format_mutator.so gcc "-shared -fPIC -O2 -w" "$(dirname "$0")/format_mutator.c"; then
+        export AFL_CUSTOM_MUTATOR_LIBRARY="$(realpath format_mutator.so)"
+        export FORMAT_MUTATOR_SCHEMA="$(realpath "$format_path")"
+    fi
+fi
+
+# Carry the coverage of earlier iterations over: minimize the collected queue and
+# crash inputs against the new binary and start from them. afl-cmin drops inputs
+# that crash, which afl-fuzz would refuse as seeds anyway.
+if [ -n "$corpus_dir" ] && [ -n "$(ls -A "$corpus_dir" 2>/dev/null)" ]; then
+    cmin_start=$(trace_now)
+    rm -rf seeds
+    if afl-cmin -i "$corpus_dir" -o seeds -m none -- "$(run_path "$file_name")" "$input_type" > cmin_log.txt 2>&1 \
+        && [ -n "$(ls -A seeds 2>/dev/null)" ]; then
+        seed_dir=seeds
+    fi
+    trace_span afl-cmin "$cmin_start" "{\"seed_dir\": \"$seed_dir\"}"
+fi
+
+# Start from a clean sync directory, so stats of stale instances never count
+rm -rf output
+mkdir -p output
+
+# start_libfuzzer <instance>
+# Fuzz in fork mode, so a crash is saved and fuzzing goes on, in a process group of its own
+start_libfuzzer() {
+    local lf_dir=output/libfuzzer
+    local lf_args=(-fork=1 -ignore_crashes=1 -ignore_timeouts=1 -ignore_ooms=1 -detect_leaks=0 -timeout=5
+                   -max_total_time="$fuzz_time" -artifact_prefix="$lf_dir/artifacts/")
+    if [ "${#dict_args[@]}" -gt 0 ]; then
+        lf_args+=(-dict="${dict_args[1]}")
+    fi
+    mkdir -p "$lf_dir/queue" "$lf_dir/crashes" "$lf_dir/artifacts"
+    libfuzzer_start_ms=$(date +%s%3N)
+    libfuzzer_crashes=0
+    if [ -n "${afl_cpus[$1]:-}" ]; then
+        setsid taskset -c "${afl_cpus[$1]}" "$libfuzzer_target" "${lf_args[@]}" "$lf_dir/queue" "$seed_dir" > "$lf_dir/log.txt" 2>&1 &
+    else
+        setsid "$libfuzzer_target" "${lf_args[@]}" "$lf_dir/queue" "$seed_dir" > "$lf_dir/log.txt" 2>&1 &
+    fi
+    libfuzzer_pid=$!
+}
+
+# collect_libfuzzer
+# Give libFuzzer's crash artifacts AFL names and write its fuzzer_stats, so the
+# rest of the pipeline reads it like any other instance of the sync directory
+collect_libfuzzer() {
+    [ -n "${libfuzzer_pid:-}" ] || return 0
+    local artifact
+    for artifact in output/libfuzzer/artifacts/crash-*; do
+        [ -e "$artifact" ] || continue
+        mv "$artifact" "$(printf 'output/libfuzzer/crashes/id:%06d,src:libfuzzer,time:%d' \
+            "$libfuzzer_crashes" "$(( $(date +%s%3N) - libfuzzer_start_ms ))")"
+        libfuzzer_crashes=$((libfuzzer_crashes + 1))
+    done
+    # Status lines start with #<runs>, in fork mode "#<runs>: ... exec/s <n>", otherwise "exec/s: <n>"
+    awk -v crashes="$libfuzzer_crashes" '
+        /^#[0-9]/ {
+            runs = substr($1, 2); sub(/:$/, "", runs)
+            if (match($0, /exec\/s:? [0-9]+/)) { rate = substr($0, RSTART, RLENGTH); sub(/.* /, "", rate) }
+        }
+        END { printf "execs_done : %d\nexecs_per_sec : %d\nsaved_crashes : %d\n", runs, rate, crashes }
+    ' output/libfuzzer/log.txt > output/libfuzzer/fuzzer_stats 2>/dev/null
+}
+
+# stop_libfuzzer
+stop_libfuzzer() {
+    [ -n "${libfuzzer_pid:-}" ] || return 0
+    kill -- "-$libfuzzer_pid" 2>/dev/null
+    wait "$libfuzzer_pid" 2>/dev/null
+    collect_libfuzzer
+}
 
-afl-fuzz -i input -o output -m none -- ./"$file_name" "$input_type" &
-afl_pid=$!
+# bind_args <instance>
+# afl-fuzz -b option pinning the instance to its CPU from AFL_CPUS, if there is one
+bind_args() {
+    if [ -n "${afl_cpus[$1]:-}" ]; then
+        echo "-b ${afl_cpus[$1]}"
+    fi
+}
+
+# The main instance keeps the UI on stdout, secondaries log into the sync directory
+fuzz_start=$(trace_now)
+# shellcheck disable=SC2046
+afl-fuzz -i "$seed_dir" -o output -M main -m none "${dict_args[@]}" "${cmplog_args[@]}" $(bind_args 0) -- "$(run_path "$fuzz_target")" "${fuzz_args[@]}" &
+afl_pids=($!)
+
+# Take the instances down with the script when it is stopped from outside
+trap 'kill "${afl_pids[@]}" 2>/dev/null; stop_libfuzzer; trace_span afl-fuzz "$fuzz_start" "{\"jobs\": $fuzz_jobs}"; exit 0' TERM
+
+afl_jobs=$fuzz_jobs
+if [ -n "$libfuzzer_target" ]; then
+    if [ "$fuzz_jobs" -gt 1 ]; then
+        afl_jobs=$((fuzz_jobs - 1))
+    fi
+    start_libfuzzer "$afl_jobs"
+fi
+
+for ((i = 1; i < afl_jobs; i++)); do
+    secondary_target="$fuzz_target"
+    if [ "$i" -eq 1 ] && [ -n "$laf_target" ]; then
+        secondary_target="$laf_target"
+    fi
+    # shellcheck disable=SC2046
+    afl-fuzz -i "$seed_dir" -o output -S "secondary$i" -m none "${dict_args[@]}" $(bind_args "$i") -- "$(run_path "$secondary_target")" "${fuzz_args[@]}" > "output/secondary$i.log" 2>&1 &
+    afl_pids+=($!)
+done
 
 sleep 1
 
-if ! kill -0 "$afl_pid" 2>/dev/null; then
+if ! kill -0 "${afl_pids[0]}" 2>/dev/null; then
+    kill "${afl_pids[@]}" 2>/dev/null
+    stop_libfuzzer
     exit 2
 fi
 
-sleep "$fuzz_time"  # Let AFL run for fuzz_time seconds
-kill $afl_pid
+# Sum or take the maximum of a fuzzer_stats field over all instances, 0 until
+# the first instance has written its stats
+stats_sum() {
+    cat output/*/fuzzer_stats 2>/dev/null | awk -F: -v key="$1" '$1 ~ "^" key " *$" { sum += $2 } END { print sum + 0 }'
+}
+stats_max() {
+    cat output/*/fuzzer_stats 2>/dev/null | awk -F: -v key="$1" '$1 ~ "^" key " *$" && $2 + 0 > max { max = $2 + 0 } END { print max + 0 }'
+}
+
+# Let AFL run for at most fuzz_time seconds, polling fuzzer_stats for an early stop
+SECONDS=0
+last_edges=-1
+plateau_start=0
+while [ "$SECONDS" -lt "$fuzz_time" ] && kill -0 "${afl_pids[0]}" 2>/dev/null; do
+    sleep 1
+    collect_libfuzzer
+    # Older AFL++ releases call the field unique_crashes
+    crashes=$(( $(stats_sum saved_crashes) + $(stats_sum unique_crashes) ))
+    if [ "$stop_crashes" -gt 0 ] && [ "$crashes" -ge "$stop_crashes" ]; then
+        break
+    fi
+    if [ "$stop_plateau" -gt 0 ] && [ "$crashes" -eq 0 ]; then
+        edges=$(stats_max edges_found)
+        if [ "$edges" -ne "$last_edges" ]; then
+            last_edges=$edges
+            plateau_start=$SECONDS
+        elif [ $((SECONDS - plateau_start)) -ge "$stop_plateau" ]; then
+            break
+        fi
+    fi
+done
+kill "${afl_pids[@]}" 2>/dev/null
+stop_libfuzzer
+trace_span afl-fuzz "$fuzz_start" "{\"jobs\": $fuzz_jobs, \"crashes\": ${crashes:-0}}"
 sleep 1
 kill -SIGINT $$
-exit 0
\ No newline at end of file
+exit 0
@@ -0,0 +1,80 @@
+#!/bin/bash
+
+# Check if sufficient arguments are provided
+if [ "$#" -lt 1 ]; then
+    echo "Usage: $0 <target...>"
+    echo "Repairs every target headless, several at a time, each in its own workspace and on its own cores"
+    echo "Optional: BATCH_DIR=<dir> holds one workspace per target and the results (default: batch)"
+    echo "Optional: CORE_BUDGET=<n> cores shared by all jobs (default: every core this script may use)"
+    echo "Optional: JOB_CORES=<n> cores given to each job, so CORE_BUDGET/JOB_CORES jobs run at once (default: 4)"
+    echo "Optional: LLM_CACHE_DIR, APR_<SETTING>, OPENAI_API_KEY and APR_SUDO_PASSWORD as for run_benchmark.sh"
+    exit 1
+fi
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+BATCH_DIR="$(realpath -m "${BATCH_DIR:-batch}")"
+JOB_CORES="${JOB_CORES:-4}"
+
+source "$SCRIPT_DIR/workspace.sh"
+
+if ! command -v jupyter > /dev/null; then
+    echo "jupyter nbconvert is required to run the notebook headless"
+    exit 1
+fi
+if [ -z "$APR_SUDO_PASSWORD" ]; then
+    read -r -s -p "Enter Sudo Password: " APR_SUDO_PASSWORD
+    echo
+fi
+export APR_SUDO_PASSWORD
+
+# Expand the CPUs this script may run on ("0-3,8,10-11") into a list
+CPUS=()
+IFS=',' read -r -a ranges <<< "$(awk '/^Cpus_allowed_list/ { print $2 }' /proc/self/status)"
+for range in "${ranges[@]}"; do
+    CPUS+=($(seq "${range%-*}" "${range#*-}"))
+done
+CORE_BUDGET="${CORE_BUDGET:-${#CPUS[@]}}"
+[ "$CORE_BUDGET" -le "${#CPUS[@]}" ] || CORE_BUDGET=${#CPUS[@]}
+[ "$JOB_CORES" -le "$CORE_BUDGET" ] || JOB_CORES=$CORE_BUDGET
+
+# The core budget is cut into slots of JOB_CORES CPUs, one job runs per slot
+SLOTS=$((CORE_BUDGET / JOB_CORES))
+declare -a slot_pids
+echo "Running up to $SLOTS jobs at once on $JOB_CORES cores each"
+
+# free_slot
+# Set slot to a slot with no running job, waiting for a job to finish if needed
+free_slot() {
+    while true; do
+        for ((slot = 0; slot < SLOTS; slot++)); do
+            if [ -z "${slot_pids[$slot]}" ] || ! kill -0 "${slot_pids[$slot]}" 2>/dev/null; then
+                return
+            fi
+        done
+        wait -n
+    done
+}
+
+for target in "$@"; do
+    target="$(realpath "$target")"
+    name="$(basename "$target")"
+    workspace="$BATCH_DIR/${name%.*}/run1"
+    make_workspace "$workspace" "$target"
+
+    free_slot
+    slot_cpus=("${CPUS[@]:$((slot * JOB_CORES)):$JOB_CORES}")
+    cpu_list=$(IFS=,; echo "${slot_cpus[*]}")
+    echo "[$name] CPUs $cpu_list"
+    (
+        # Everything the job starts inherits the slot's affinity, so nproc and the
+        # notebook's fuzz_jobs see JOB_CORES cores, and afl-fuzz -b pins one instance per CPU
+        taskset -pc "$cpu_list" "$BASHPID" > /dev/null
+        export AFL_CPUS="$cpu_list"
+        run_workspace "$workspace" "$target"
+        echo "[$name] done"
+    ) &
+    slot_pids[$slot]=$!
+done
+wait
+
+python3 "$SCRIPT_DIR/benchmark_report.py" "$BATCH_DIR"
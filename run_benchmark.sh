@@ -0,0 +1,58 @@
+#!/bin/bash
+
+# Check if sufficient arguments are provided
+if [ "$#" -lt 1 ]; then
+    echo "Usage: $0 <runs> [target...]"
+    echo "Runs the notebook headless <runs> times on every target (default: data/*.c data/*.cpp)"
+    echo "and writes per-run and per-target metrics to results.json and results.csv"
+    echo "Optional: BENCH_DIR=<dir> holds one workspace per target and run, and the results (default: benchmark)"
+    echo "Optional: LLM_CACHE_DIR=<dir> shares one LLM response cache between all runs (default: one per run)"
+    echo "Optional: APR_<SETTING>=<value> overrides a notebook setting, e.g. APR_FUZZ_TIME=60 APR_PIPELINED=false"
+    echo "Optional: OPENAI_API_KEY and APR_SUDO_PASSWORD are read instead of prompting"
+    exit 1
+fi
+
+RUNS="$1"
+shift
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+BENCH_DIR="$(realpath -m "${BENCH_DIR:-benchmark}")"
+
+if [ "$#" -gt 0 ]; then
+    TARGETS=("$@")
+else
+    TARGETS=()
+    for target in "$SCRIPT_DIR"/data/*.c "$SCRIPT_DIR"/data/*.cpp; do
+        # Harnesses generated next to a target are not targets of their own
+        case "$target" in
+            *_harness.*|*_libfuzzer.*) ;;
+            *) TARGETS+=("$target") ;;
+        esac
+    done
+fi
+
+if ! command -v jupyter > /dev/null; then
+    echo "jupyter nbconvert is required to run the notebook headless"
+    exit 1
+fi
+if [ -z "$APR_SUDO_PASSWORD" ]; then
+    read -r -s -p "Enter Sudo Password: " APR_SUDO_PASSWORD
+    echo
+fi
+export APR_SUDO_PASSWORD
+
+source "$SCRIPT_DIR/workspace.sh"
+
+for target in "${TARGETS[@]}"; do
+    target="$(realpath "$target")"
+    name="$(basename "$target")"
+    for run in $(seq 1 "$RUNS"); do
+        # Every run gets a fresh workspace and all the cores
+        workspace="$BENCH_DIR/${name%.*}/run$run"
+        make_workspace "$workspace" "$target"
+
+        echo "[$name run $run/$RUNS]"
+        run_workspace "$workspace" "$target"
+    done
+done
+
+python3 "$SCRIPT_DIR/benchmark_report.py" "$BENCH_DIR"
@@ -2,7 +2,9 @@
 
 # Check if sufficient arguments are provided
 if [ "$#" -ne 4 ]; then
-    echo "Usage: $0 <compiled_program_path> <input_type> <crash_dir> <num_crashes_to_try>"
+    echo "Usage: $0 <compiled_program_path> <input_type> <crash_dir|crash_list_file> <num_crashes_to_try>"
+    echo "Optional: TRIAGE_BACKEND=sanitizer replays crashes through an ASan/UBSan build first (default: gdb)"
+    echo "Optional: TRIAGE_CORES=1 replays crashes with core dumps enabled and unwinds the cores in parallel"
     exit 1
 fi
 
@@ -12,35 +14,119 @@ COMPILED_PROGRAM="${COMPILED_PROGRAM_PATH%.*}"
 INPUT_TYPE="$2"
 CRASH_DIR="$3"
 NUM_CRASHES="$4"
+TRIAGE_BACKEND="${TRIAGE_BACKEND:-gdb}"
+TRIAGE_CORES="${TRIAGE_CORES:-0}"
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
 
-# Counter for crashes analyzed
-CRASH_COUNT=0
+source "$SCRIPT_DIR/build_cache.sh"
+
+# CRASH_DIR is either a single crashes directory or an AFL sync directory
+# holding one crashes directory per instance; visit them in byte order
+shopt -s nullglob
+export LC_ALL=C
+
+CRASH_LIST=$(mktemp)
+GDB_LIST=$(mktemp)
+TRIAGE_OUTPUT=$(mktemp)
+CORE_DIR=$(mktemp -d)
+trap 'rm -rf "$CRASH_LIST" "$GDB_LIST" "$TRIAGE_OUTPUT" "$CORE_DIR"' EXIT
+
+# Collect the crash files to analyze, a regular file lists them one per line
+if [ -f "$CRASH_DIR" ]; then
+    mapfile -t CRASH_FILES < "$CRASH_DIR"
+else
+    CRASH_FILES=("$CRASH_DIR"/id:* "$CRASH_DIR"/*/crashes/id:*)
+fi
 
-# Iterate through crash files in the directory
-for CRASH_FILE in "$CRASH_DIR"/id:*; do
-    # Stop if we have processed the desired number of crashes
+CRASH_COUNT=0
+for CRASH_FILE in "${CRASH_FILES[@]}"; do
+    # Stop if we have collected the desired number of crashes
     if [ "$CRASH_COUNT" -ge "$NUM_CRASHES" ]; then
         break
     fi
+    realpath "$CRASH_FILE" >> "$CRASH_LIST"
+    CRASH_COUNT=$((CRASH_COUNT + 1))
+done
 
-    # Run gdb to analyze the crash
-    if [ "$INPUT_TYPE" == "@@" ]; then
-        # Input from file
-        gdb_output=$(gdb --batch --ex "file $COMPILED_PROGRAM" --ex "run $CRASH_FILE" --ex "backtrace" 2>/dev/null)
-    elif [ "$INPUT_TYPE" == "@" ]; then
-        # Input from stdin
-        gdb_output=$(gdb --batch --ex "file $COMPILED_PROGRAM" --ex "run < $CRASH_FILE" --ex "backtrace" 2>/dev/null)
-    fi
+cp "$CRASH_LIST" "$GDB_LIST"
 
-    # Extract the function causing the crash from the gdb output
-    crash_function=$(echo "$gdb_output")
+if [ "$TRIAGE_BACKEND" == "sanitizer" ]; then
+    # The sanitizer build is cached per version of the source
+    SANITIZER_PROGRAM="${COMPILED_PROGRAM}_asan"
+    SANITIZER_CC=$(compiler_for "$COMPILED_PROGRAM_PATH" gcc g++)
 
-    # Output the results
-    if [ -n "$crash_function" ]; then
-        echo "$crash_function"
-    else
-        echo "None"
+    # Crashes without a sanitizer report are left in GDB_LIST for gdb
+    if cached_build "$SANITIZER_PROGRAM" "$SANITIZER_CC" "-g -w -fsanitize=address,undefined -fno-omit-frame-pointer" \
+        "$COMPILED_PROGRAM_PATH"; then
+        SANITIZER_START=$(trace_now)
+        python3 "$SCRIPT_DIR/triage_sanitizer.py" "$SANITIZER_PROGRAM" "$COMPILED_PROGRAM_PATH" \
+            "$INPUT_TYPE" "$CRASH_LIST" "$GDB_LIST"
+        trace_span "sanitizer replay" "$SANITIZER_START" "{\"crashes\": $CRASH_COUNT}"
     fi
+fi
 
-    CRASH_COUNT=$((CRASH_COUNT + 1))
-done
+# gdb debugs an uninstrumented -O0 build, also cached per version of the source
+DEBUG_PROGRAM="${COMPILED_PROGRAM}_debug"
+if [ -s "$GDB_LIST" ]; then
+    cached_build "$DEBUG_PROGRAM" "$(compiler_for "$COMPILED_PROGRAM_PATH" gcc g++)" "-g -O0 -w" "$COMPILED_PROGRAM_PATH"
+    DEBUG_PROGRAM="$(realpath "$DEBUG_PROGRAM")"
+fi
+
+# Post-mortem triage: every remaining crash is replayed once with core dumps enabled,
+# each in a directory of its own, then one gdb per core unwinds it, across all cores.
+# Crashes that left no core (no crash, or core_pattern pipes cores elsewhere) stay in
+# GDB_LIST for the live gdb session below.
+capture_core() {
+    local dir="$CORE_DIR/$1"
+    mkdir -p "$dir"
+    echo "$2" > "$dir/input"
+    (
+        cd "$dir" || exit
+        ulimit -c unlimited 2>/dev/null
+        if [ "$INPUT_TYPE" == "@@" ]; then
+            timeout 10 "$DEBUG_PROGRAM" "$2" < /dev/null > /dev/null 2>&1
+        else
+            timeout 10 "$DEBUG_PROGRAM" < "$2" > /dev/null 2>&1
+        fi
+    )
+}
+unwind_core() {
+    local dir="$1"
+    local core
+    core=$(find "$dir" -maxdepth 1 -name 'core*' -type f | head -n 1)
+    [ -n "$core" ] || return 0
+    TRIAGE_CORE_INPUT="$(cat "$dir/input")" TRIAGE_OUTPUT="$dir/record.json" \
+        gdb --batch -nx -c "$core" -x "$SCRIPT_DIR/triage_gdb.py" "$DEBUG_PROGRAM" > /dev/null 2>&1
+}
+export -f capture_core unwind_core
+export CORE_DIR DEBUG_PROGRAM INPUT_TYPE SCRIPT_DIR
+
+if [ "$TRIAGE_CORES" == "1" ] && [ -s "$GDB_LIST" ]; then
+    CORE_START=$(trace_now)
+    awk '{ print NR, $0 }' "$GDB_LIST" | xargs -r -L 1 -P "$(nproc)" bash -c 'capture_core "$1" "$2"' _
+    find "$CORE_DIR" -mindepth 1 -maxdepth 1 -type d -print0 \
+        | xargs -0 -r -n 1 -P "$(nproc)" bash -c 'unwind_core "$1"' _
+    trace_span "core triage" "$CORE_START" "{\"crashes\": $(wc -l < "$GDB_LIST")}"
+
+    # Crashes with a post-mortem record are done, the rest go to the live session
+    UNWOUND=$(mktemp)
+    for RECORD in "$CORE_DIR"/*/record.json; do
+        if grep -q '"backtrace": \[{' "$RECORD"; then
+            cat "$RECORD"
+            cat "$(dirname "$RECORD")/input" >> "$UNWOUND"
+        fi
+    done
+    grep -vxF -f "$UNWOUND" "$GDB_LIST" > "$GDB_LIST.rest"
+    mv "$GDB_LIST.rest" "$GDB_LIST"
+    rm -f "$UNWOUND"
+fi
+
+# Replay every remaining crash in one gdb session, symbols are loaded only once.
+# Each crash produces one JSON record (signal, faulting frame, backtrace).
+if [ -s "$GDB_LIST" ]; then
+    GDB_START=$(trace_now)
+    TRIAGE_INPUT_TYPE="$INPUT_TYPE" TRIAGE_CRASHES="$GDB_LIST" TRIAGE_OUTPUT="$TRIAGE_OUTPUT" \
+        gdb --batch -nx -x "$SCRIPT_DIR/triage_gdb.py" --args "$DEBUG_PROGRAM" > /dev/null 2>&1
+    trace_span "gdb session" "$GDB_START" "{\"crashes\": $(wc -l < "$GDB_LIST")}"
+    cat "$TRIAGE_OUTPUT"
+fi
@@ -0,0 +1,49 @@
+#!/bin/bash
+
+# Check if sufficient arguments are provided
+if [ "$#" -ne 3 ]; then
+    echo "Usage: $0 <file_path> <input_type> <crash_dir>"
+    echo "Optional: REPLAY_TIMEOUT=<seconds> per-input timeout (default: 5)"
+    exit 1
+fi
+
+# Read arguments
+FILE_PATH="$1"
+PROGRAM="${FILE_PATH%.*}_debug"
+INPUT_TYPE="$2"
+CRASH_DIR="$3"
+REPLAY_TIMEOUT="${REPLAY_TIMEOUT:-5}"
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+
+source "$SCRIPT_DIR/build_cache.sh"
+
+cached_build "$PROGRAM" "$(compiler_for "$FILE_PATH" gcc g++)" "-g -O0 -w" "$FILE_PATH" || exit 2
+PROGRAM="$(realpath "$PROGRAM")"
+
+# Replay one input, print it and exit 255 if the program was killed by a signal
+# (status above 128). A timeout makes timeout exit with 124, so a hang is not
+# counted as a crash. Exit status 255 makes xargs stop handing out
+# further inputs, so a patch that still crashes is rejected as early as possible.
+replay() {
+    if [ "$INPUT_TYPE" == "@@" ]; then
+        timeout "$REPLAY_TIMEOUT" "$PROGRAM" "$1" < /dev/null > /dev/null 2>&1
+    else
+        timeout "$REPLAY_TIMEOUT" "$PROGRAM" < "$1" > /dev/null 2>&1
+    fi
+    status=$?
+    if [ "$status" -gt 128 ]; then
+        echo "$1"
+        exit 255
+    fi
+    exit 0
+}
+export -f replay
+export PROGRAM INPUT_TYPE REPLAY_TIMEOUT
+
+# Every known crash input is replayed in parallel against the new binary
+REPLAY_START=$(trace_now)
+find "$CRASH_DIR" -maxdepth 1 -type f -name 'id:*' -print0 \
+    | xargs -0 -r -n 1 -P "$(nproc)" bash -c 'replay "$1"' _ 2>/dev/null
+trace_span replay "$REPLAY_START"
+
+exit 0
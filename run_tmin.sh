@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Check if sufficient arguments are provided
+if [ "$#" -ne 3 ]; then
+    echo "Usage: $0 <file_path> <input_type> <minimize_list>"
+    echo "Each line of minimize_list is \"<crash_input> <minimized_output>\""
+    echo "Optional: TMIN_TIMEOUT=<seconds> caps afl-tmin per input (default: 10)"
+    exit 1
+fi
+
+# Read arguments
+FILE_PATH="$1"
+PROGRAM="${FILE_PATH%.*}"
+INPUT_TYPE="$2"
+MINIMIZE_LIST="$3"
+TMIN_TIMEOUT="${TMIN_TIMEOUT:-10}"
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+
+source "$SCRIPT_DIR/build_cache.sh"
+
+# afl-tmin needs the instrumented build, the same one run_afl.sh fuzzes
+cached_build "$PROGRAM" "$(compiler_for "$FILE_PATH" afl-gcc afl-g++)" "-g -w" "$FILE_PATH" || exit 2
+PROGRAM="$(realpath "$PROGRAM")"
+
+# Minimize one crash input within TMIN_TIMEOUT seconds. afl-tmin keeps the crash
+# the input triggers; when it fails or runs out of time the input is left as it is.
+minimize() {
+    if ! timeout "$TMIN_TIMEOUT" afl-tmin -i "$1" -o "$2.tmp" -m none -- "$PROGRAM" "$INPUT_TYPE" > /dev/null 2>&1 \
+        || [ ! -s "$2.tmp" ]; then
+        rm -f "$2.tmp"
+        cp "$1" "$2"
+        return
+    fi
+    mv -f "$2.tmp" "$2"
+}
+export -f minimize
+export PROGRAM INPUT_TYPE TMIN_TIMEOUT
+
+# One afl-tmin per core, every input is minimized independently
+TMIN_START=$(trace_now)
+xargs -r -L 1 -P "$(nproc)" bash -c 'minimize "$1" "$2"' _ < "$MINIMIZE_LIST"
+trace_span afl-tmin "$TMIN_START" "{\"inputs\": $(wc -l < "$MINIMIZE_LIST")}"
+
+exit 0
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# Trace spans of the bash stages, sourced through build_cache.sh. When the notebook sets
+# TRACE_EVENTS, every span is appended to that file as one Chrome trace event per line
+# and merged into the notebook's trace.json, on a track of its own per script.
+
+# trace_now
+# Microseconds since the epoch, the clock the notebook's tracer uses too
+trace_now() {
+    date +%s%6N
+}
+
+# trace_span <name> <start_us> [<args_json>]
+# Record a span from start_us until now
+trace_span() {
+    [ -n "$TRACE_EVENTS" ] || return 0
+    local end
+    end=$(trace_now)
+    local args="${3:-}"
+    [ -n "$args" ] || args="{}"
+    printf '{"name": "%s", "cat": "script", "ph": "X", "ts": %s, "dur": %s, "pid": %s, "tid": %s, "args": %s}\n' \
+        "$1" "$2" "$((end - $2))" "${TRACE_PID:-$$}" "$$" "$args" >> "$TRACE_EVENTS"
+}
@@ -0,0 +1,142 @@
+# Batched crash triage, run inside a single gdb session by run_gdb.sh:
+#   gdb --batch -nx -x triage_gdb.py --args <compiled_program>
+#
+# TRIAGE_INPUT_TYPE  "@" (crash input on stdin) or "@@" (crash input as argv[1])
+# TRIAGE_CRASHES     file listing one crash input path per line
+# TRIAGE_OUTPUT      file receiving one JSON record per crash input
+# TRIAGE_TIMEOUT     seconds each crash input may run before it is killed (default 10)
+#
+# Post-mortem triage of a core dump, one gdb per core, also run by run_gdb.sh:
+#   gdb --batch -nx -c <core> -x triage_gdb.py <compiled_program>
+#
+# TRIAGE_CORE_INPUT  crash input that produced the core
+# TRIAGE_OUTPUT      file receiving the JSON record of that crash input
+import json
+import os
+import signal
+import threading
+
+import gdb
+
+output_path = os.environ["TRIAGE_OUTPUT"]
+
+gdb.execute("set pagination off")
+gdb.execute("set confirm off")
+gdb.execute("set width unlimited")
+try:
+    gdb.execute("set debuginfod enabled off")
+except gdb.error:
+    pass
+
+program = gdb.current_progspace().filename
+last_signal = None
+
+
+def on_stop(event):
+    global last_signal
+    if isinstance(event, gdb.SignalEvent):
+        last_signal = event.stop_signal
+
+
+gdb.events.stop.connect(on_stop)
+
+
+def frame_record(frame):
+    sal = frame.find_sal()
+    symtab = sal.symtab
+    return {
+        "function": frame.name() or "??",
+        "file": symtab.filename if symtab else None,
+        "line": sal.line if symtab else None,
+        "pc": hex(frame.pc()),
+        "in_program": symtab is not None and symtab.objfile.filename == program,
+    }
+
+
+def triage(crash_file):
+    global last_signal
+    last_signal = None
+
+    # Program output is discarded so it cannot mix with gdb's own
+    if input_type == "@@":
+        gdb.execute(f"starti '{crash_file}' > /dev/null 2>&1", to_string=True)
+    else:
+        gdb.execute(f"starti < '{crash_file}' > /dev/null 2>&1", to_string=True)
+
+    # A hanging input is killed after the timeout, like the other triage backends,
+    # so it is recorded as no crash instead of stalling every later input
+    expired = threading.Event()
+    pid = gdb.selected_inferior().pid
+
+    def kill_inferior():
+        expired.set()
+        os.kill(pid, signal.SIGKILL)
+
+    timer = threading.Timer(timeout, kill_inferior)
+    timer.start()
+    try:
+        last_signal = None
+        gdb.execute("continue", to_string=True)
+    finally:
+        timer.cancel()
+
+    if expired.is_set():
+        return {"input": crash_file, "backend": "gdb", "signal": None, "frame": None, "backtrace": [], "stacktrace": "", "timeout": True}
+
+    record = {"input": crash_file, "backend": "gdb", "signal": last_signal, "frame": None, "backtrace": [], "stacktrace": ""}
+    if last_signal is None or not gdb.selected_inferior().pid:
+        return record
+
+    add_backtrace(record)
+    gdb.execute("kill", to_string=True)
+    return record
+
+
+def add_backtrace(record):
+    """Fill in the backtrace of the stopped (or dumped) program."""
+    frames = []
+    frame = gdb.newest_frame()
+    while frame is not None:
+        frames.append(frame_record(frame))
+        frame = frame.older()
+
+    record["backtrace"] = frames
+    # The faulting frame is the innermost one inside the program's own sources
+    record["frame"] = next((f for f in frames if f["in_program"]), frames[0] if frames else None)
+    record["stacktrace"] = gdb.execute("backtrace", to_string=True)
+
+
+def post_mortem(crash_file):
+    """Triage the core dump gdb was started on, the crash state is already loaded."""
+    record = {"input": crash_file, "backend": "core", "signal": None, "frame": None, "backtrace": [], "stacktrace": ""}
+    try:
+        record["signal"] = signal.Signals(int(gdb.parse_and_eval("$_siginfo.si_signo"))).name
+    except (gdb.error, ValueError):
+        pass
+    add_backtrace(record)
+    return record
+
+
+if "TRIAGE_CORE_INPUT" in os.environ:
+    crash_file = os.environ["TRIAGE_CORE_INPUT"]
+    try:
+        record = post_mortem(crash_file)
+    except gdb.error as e:
+        record = {"input": crash_file, "backend": "core", "signal": None, "frame": None, "backtrace": [], "stacktrace": "", "error": str(e)}
+    with open(output_path, "w") as output:
+        output.write(json.dumps(record) + "\n")
+else:
+    input_type = os.environ["TRIAGE_INPUT_TYPE"]
+    timeout = float(os.environ.get("TRIAGE_TIMEOUT", "10"))
+    crash_list = os.environ["TRIAGE_CRASHES"]
+    with open(crash_list) as crashes, open(output_path, "w") as output:
+        for line in crashes:
+            crash_file = line.rstrip("\n")
+            if not crash_file:
+                continue
+            try:
+                record = triage(crash_file)
+            except gdb.error as e:
+                record = {"input": crash_file, "backend": "gdb", "signal": None, "frame": None, "backtrace": [], "stacktrace": "", "error": str(e)}
+            output.write(json.dumps(record) + "\n")
+            output.flush()
@@ -0,0 +1,133 @@
+# Sanitizer-backed crash triage, run by run_gdb.sh:
+#   python3 triage_sanitizer.py <sanitizer_program> <source_path> <input_type> <crash_list> <unhandled_list>
+#
+# Every crash input listed in crash_list is replayed through the ASan/UBSan build of
+# the program and the sanitizer report is parsed into one JSON record per crash on
+# stdout. Inputs that produce no report are written to unhandled_list for gdb.
+import json
+import os
+import re
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+
+REPLAY_TIMEOUT = 10
+
+SANITIZER_ENV = dict(
+    os.environ,
+    ASAN_OPTIONS="detect_leaks=0:abort_on_error=0:symbolize=1:allocator_may_return_null=1",
+    UBSAN_OPTIONS="print_stacktrace=1:halt_on_error=1:symbolize=1",
+)
+
+ERROR_LINE = re.compile(r'ERROR: AddressSanitizer: (?:attempting )?([\w-]+)')
+UBSAN_LINE = re.compile(r'^(\S+?):(\d+):\d+: runtime error: (.*)$', re.MULTILINE)
+ACCESS_LINE = re.compile(r'^(READ|WRITE) of size (\d+)', re.MULTILINE)
+FRAME_LINE = re.compile(r'^\s*#(\d+) (0x[0-9a-f]+) (?:in (\S+) )?\s*(.*)$')
+
+# ASan names deadly signals after the signal itself
+SIGNALS = {"SEGV": "SIGSEGV", "FPE": "SIGFPE", "BUS": "SIGBUS", "ILL": "SIGILL", "ABRT": "SIGABRT"}
+
+
+def parse_frame(match, source_name):
+    location = match.group(4).strip()
+    file, line = None, None
+    if not location.startswith("("):
+        parts = location.split(":")
+        file = parts[0]
+        if len(parts) > 1 and parts[1].isdigit():
+            line = int(parts[1])
+    return {
+        "function": match.group(3) or "??",
+        "file": file,
+        "line": line,
+        "pc": match.group(2),
+        "in_program": file is not None and os.path.basename(file) == source_name,
+    }
+
+
+def parse_report(report, source_name):
+    """Split a sanitizer report into its bug class, access and stacks."""
+    error = ERROR_LINE.search(report)
+    ubsan = UBSAN_LINE.search(report)
+    if error:
+        bug_class = error.group(1)
+    elif ubsan:
+        bug_class = ubsan.group(3)
+    else:
+        return None
+
+    access = ACCESS_LINE.search(report)
+    stacks = {"crash": [], "freed": [], "allocated": []}
+    section = "crash"
+    for line in report.splitlines():
+        if "freed by thread" in line:
+            section = "freed"
+        elif "allocated by thread" in line:
+            section = "allocated"
+        else:
+            match = FRAME_LINE.match(line)
+            if match:
+                stacks[section].append(parse_frame(match, source_name))
+
+    # The report ends at its SUMMARY line, the shadow memory dump after it only bloats the prompt
+    start = error.start() if error else ubsan.start()
+    start = report.rfind("\n", 0, start) + 1
+    summary = report.find("SUMMARY:", start)
+    end = report.find("\n", summary) if summary != -1 else report.find("Shadow bytes around", start)
+    return {
+        "signal": SIGNALS.get(bug_class),
+        "bug_class": bug_class,
+        "access": f"{access.group(1)} of size {access.group(2)}" if access else None,
+        "frame": next((f for f in stacks["crash"] if f["in_program"]), stacks["crash"][0] if stacks["crash"] else None),
+        "backtrace": stacks["crash"],
+        "freed_stack": stacks["freed"],
+        "allocated_stack": stacks["allocated"],
+        "stacktrace": report[start:end if end != -1 else len(report)].strip(),
+    }
+
+
+def replay(program, source_name, input_type, crash_file):
+    try:
+        if input_type == "@@":
+            result = subprocess.run([program, crash_file], stdin=subprocess.DEVNULL,
+                                    stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                                    env=SANITIZER_ENV, timeout=REPLAY_TIMEOUT)
+        else:
+            with open(crash_file, "rb") as crash_input:
+                result = subprocess.run([program], stdin=crash_input,
+                                        stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                                        env=SANITIZER_ENV, timeout=REPLAY_TIMEOUT)
+    except subprocess.TimeoutExpired:
+        return None
+
+    parsed = parse_report(result.stderr.decode(errors="ignore"), source_name)
+    if parsed is None:
+        return None
+    return {"input": crash_file, "backend": "sanitizer", **parsed}
+
+
+def main():
+    if len(sys.argv) != 6:
+        print(f"Usage: {sys.argv[0]} <sanitizer_program> <source_path> <input_type> <crash_list> <unhandled_list>")
+        sys.exit(1)
+
+    program, source_path, input_type, crash_list, unhandled_list = sys.argv[1:]
+    program = os.path.abspath(program)
+    source_name = os.path.basename(source_path)
+    with open(crash_list) as crashes:
+        crash_files = [line.rstrip("\n") for line in crashes if line.strip()]
+
+    # Replays are independent processes, run them across all cores this process may use
+    with ThreadPoolExecutor(max_workers=len(os.sched_getaffinity(0))) as executor:
+        records = list(executor.map(lambda f: replay(program, source_name, input_type, f), crash_files))
+
+    with open(unhandled_list, "w") as unhandled:
+        for crash_file, record in zip(crash_files, records):
+            if record is None:
+                unhandled.write(crash_file + "\n")
+            else:
+                print(json.dumps(record))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# Isolated notebook workspaces, sourced by run_benchmark.sh and run_batch.sh. The notebook
+# writes input/, output/, fixed_code.* and the rest of its state to its cwd, so every job
+# runs in a directory of its own holding the target, the notebook and links to the scripts.
+WORKSPACE_SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+
+# make_workspace <workspace> <target>
+# Create a fresh workspace for target. Builds are content-addressed, so all workspaces
+# share one build cache; LLM_CACHE_DIR, when set, is shared as the LLM response cache.
+make_workspace() {
+    local workspace="$1"
+    local target="$2"
+    local name
+    name="$(basename "$target")"
+
+    rm -rf "$workspace"
+    mkdir -p "$workspace/data" "$WORKSPACE_SCRIPT_DIR/.build_cache"
+    cp "$target" "$workspace/data/$name"
+    # Format description for the structure-aware mutator, if the target has one
+    if [ -f "${target%.*}.fmt" ]; then
+        cp "${target%.*}.fmt" "$workspace/data/"
+    fi
+    cp "$WORKSPACE_SCRIPT_DIR/LLM-APR-Code.ipynb" "$workspace/"
+    for script in run_afl.sh run_gdb.sh run_replay.sh run_tmin.sh build_cache.sh trace.sh afl_dict.py format_mutator.c triage_gdb.py triage_sanitizer.py; do
+        ln -s "$WORKSPACE_SCRIPT_DIR/$script" "$workspace/$script"
+    done
+    ln -s "$WORKSPACE_SCRIPT_DIR/.build_cache" "$workspace/.build_cache"
+    if [ -n "$LLM_CACHE_DIR" ]; then
+        mkdir -p "$LLM_CACHE_DIR"
+        ln -s "$(realpath "$LLM_CACHE_DIR")" "$workspace/llm_cache"
+    fi
+}
+
+# run_workspace <workspace> <target>
+# Execute the notebook headless on target inside workspace, metrics go to metrics.json
+run_workspace() {
+    local workspace="$1"
+    local name
+    name="$(basename "$2")"
+    (
+        cd "$workspace" || exit 1
+        APR_TARGET="data/$name" APR_METRICS=metrics.json \
+            jupyter nbconvert --to notebook --execute --ExecutePreprocessor.timeout=-1 \
+            --output executed.ipynb LLM-APR-Code.ipynb > nbconvert_log.txt 2>&1
+    ) || echo "Notebook failed, see $workspace/nbconvert_log.txt"
+}